@@ -9,6 +9,11 @@ import subprocess
 import json
 import sys
 import math
+import atexit
+import threading
+import os
+import select
+import time
 
 app = Flask(__name__)
 CORS(app)
@@ -19,6 +24,9 @@ if sys.platform == "win32":
 else:
     CPP_EXECUTABLE = "./memory_graph_app"
 
+# Seconds to wait for one reply before the backend is treated as hung
+CPP_TIMEOUT = 5
+
 # In-memory state to persist between requests
 app_state = {
     "concepts": [],
@@ -97,24 +105,105 @@ def initialize_state():
         
         app_state["initialized"] = True
 
+class CppBackend:
+    """Long-lived C++ process serving newline-framed commands over stdin/stdout.
+
+    One resident MemoryGraph answers every request, so calls no longer pay
+    process start-up and sample-data initialisation, and state persists.
+    """
+
+    def __init__(self, executable, timeout=CPP_TIMEOUT):
+        self.executable = executable
+        self.timeout = timeout
+        self.process = None
+        self.pending = b""
+        self.lock = threading.Lock()
+
+    def _ensure_running(self):
+        if self.process is None or self.process.poll() is not None:
+            self.process = subprocess.Popen(
+                [self.executable],
+                stdin=subprocess.PIPE,
+                stdout=subprocess.PIPE,
+                bufsize=0,
+            )
+            self.pending = b""
+
+    def _kill(self):
+        try:
+            self.process.kill()
+            self.process.wait(timeout=self.timeout)
+        except (OSError, subprocess.TimeoutExpired):
+            pass
+        self.process = None
+
+    def _read_line(self):
+        """Read one reply line, raising TimeoutError past the deadline.
+
+        Reads the pipe directly so select() never misses buffered data.
+        Windows pipes do not support select(), so there the read blocks.
+        """
+        deadline = time.monotonic() + self.timeout
+        fd = self.process.stdout.fileno()
+        while b"\n" not in self.pending:
+            if sys.platform != "win32":
+                remaining = deadline - time.monotonic()
+                if remaining <= 0 or not select.select([fd], [], [], remaining)[0]:
+                    raise TimeoutError("C++ backend timed out")
+            chunk = os.read(fd, 65536)
+            if not chunk:
+                return ""
+            self.pending += chunk
+        line, _, self.pending = self.pending.partition(b"\n")
+        return line.decode("utf-8") + "\n"
+
+    def request(self, command, data=""):
+        line = f"{command} {data}" if data else command
+        if "\n" in line or "\r" in line:
+            raise ValueError("Commands cannot contain line breaks")
+        with self.lock:
+            self._ensure_running()
+            try:
+                self.process.stdin.write((line + "\n").encode("utf-8"))
+                self.process.stdin.flush()
+                reply = self._read_line()
+            except TimeoutError:
+                # A hung backend would hold the lock for every other request;
+                # the next request starts a fresh process
+                self._kill()
+                raise
+            except (BrokenPipeError, OSError):
+                reply = ""
+            if not reply:
+                self.process = None
+                raise RuntimeError("C++ backend exited unexpectedly")
+            return reply
+
+    def close(self):
+        with self.lock:
+            if self.process is not None and self.process.poll() is None:
+                try:
+                    self.process.stdin.write(b"EXIT\n")
+                    self.process.stdin.close()
+                    self.process.wait(timeout=5)
+                except (OSError, subprocess.TimeoutExpired):
+                    self.process.kill()
+            self.process = None
+
+cpp_backend = CppBackend(CPP_EXECUTABLE)
+atexit.register(cpp_backend.close)
+
 def run_cpp_command(command, data=""):
     """Execute C++ backend command"""
     try:
-        if data:
-            result = subprocess.run([CPP_EXECUTABLE, command, data], capture_output=True, text=True, timeout=5)
-        else:
-            result = subprocess.run([CPP_EXECUTABLE, command], capture_output=True, text=True, timeout=5)
-
-        if result.returncode != 0:
-            return {"status": "error", "message": result.stderr or "C++ executable returned error"}
-
+        reply = cpp_backend.request(command, data)
         try:
-            return json.loads(result.stdout)
+            return json.loads(reply)
         except json.JSONDecodeError as e:
-            return {"status": "error", "message": f"Invalid JSON from C++ backend: {e}. Output: {result.stdout[:100]}"}
+            return {"status": "error", "message": f"Invalid JSON from C++ backend: {e}. Output: {reply[:100]}"}
     except FileNotFoundError:
         return {"status": "error", "message": f"C++ executable not found: {CPP_EXECUTABLE}. Please compile main.cpp first."}
-    except subprocess.TimeoutExpired:
+    except TimeoutError:
         return {"status": "error", "message": "C++ backend timed out"}
     except Exception as e:
         return {"status": "error", "message": str(e)}
@@ -245,6 +334,14 @@ def set_decay_rate():
     result = run_cpp_command("SET_DECAY_RATE", str(rate))
     return jsonify(result)
 
+@app.route('/metrics', methods=['GET'])
+def metrics():
+    """Backend command latencies and gauges in Prometheus text format"""
+    result = run_cpp_command("METRICS", "prometheus")
+    if result.get("format") != "prometheus":
+        return jsonify(result), 503
+    return result["text"], 200, {"Content-Type": "text/plain; version=0.0.4"}
+
 # Serve static files (HTML, CSS, JS)
 @app.route('/')
 def index():